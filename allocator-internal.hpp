@@ -44,6 +44,9 @@ struct alloc_outer {
 
         std::tuple<StaticArgs*...> static_args;
         std::tuple<std::unique_ptr<DynamicArgs>...> allocated_dynamic_args;
+        // what serialize() reads: either the owned allocation above or a
+        // caller-held object recorded by borrow_arg
+        std::tuple<const DynamicArgs*...> dynamic_args;
         static const constexpr auto dynamic_arg_count = sizeof...(DynamicArgs);
 
         alloc_inner(char_p serial_region, std::size_t serial_size)
@@ -83,6 +86,7 @@ struct alloc_outer {
                 } else {
                     auto& uptr = std::get<arg - sizeof...(StaticArgs)>(allocated_dynamic_args);
                     uptr.reset(new Arg(std::forward<CArgs>(cargs)...));
+                    std::get<arg - sizeof...(StaticArgs)>(dynamic_args) = uptr.get();
                     return arg_ptr<Arg>{uptr.get()};
                 }
             } else {
@@ -91,12 +95,38 @@ struct alloc_outer {
             }
         }
 
+        // See message_builder::borrow_arg for the lifetime contract.  Static
+        // arguments already live in the serial region, so borrowing one is
+        // just the copy into the region.
+        template <std::size_t arg>
+        decltype(auto) borrow_arg(const get_arg<arg>& borrowed) {
+            constexpr bool arg_in_bounds = (arg < (sizeof...(StaticArgs) + sizeof...(DynamicArgs)));
+            static_assert(arg_in_bounds, "Error: index out of bounds");
+            if constexpr(arg_in_bounds) {
+                using Arg = get_arg<arg>;
+                if constexpr(is_static<arg>()) {
+                    auto* sarg = std::get<arg>(static_args);
+                    new(sarg) Arg{borrowed};
+                    return arg_ptr<const Arg>{sarg};
+                } else {
+                    // any value built earlier for this index is left alive
+                    // (until the builder is destroyed) so that arg_ptrs to
+                    // it stay valid; it just isn't serialized
+                    std::get<arg - sizeof...(StaticArgs)>(dynamic_args) = &borrowed;
+                    return arg_ptr<const Arg>{&borrowed};
+                }
+            } else {
+                struct error_arg_out_of_bounds {};
+                return error_arg_out_of_bounds{};
+            }
+        }
+
         char* serialize() const {
             std::size_t offset{static_arg_size};
             unsigned char* step1 = serial_region;
             char* region_start = (char*)step1;
-            mutils::foreach(allocated_dynamic_args, [&](const auto& uptr) {
-                offset += mutils::to_bytes(*uptr, offset + region_start);
+            mutils::foreach(dynamic_args, [&](const auto* arg) {
+                offset += mutils::to_bytes(*arg, offset + region_start);
             });
             return region_start;
         }
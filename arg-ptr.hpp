@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <type_traits>
 
 namespace derecho::derecho_allocator {
 
@@ -17,4 +18,10 @@ struct deleter {
 
 template <typename T>
 using arg_ptr = std::unique_ptr<T, internal::deleter<T>>;
+
+namespace internal {
+// accepts both built (arg_ptr<T>) and borrowed (arg_ptr<const T>) arguments
+template <typename T, typename Ptr>
+constexpr bool is_arg_ptr_for = std::is_same_v<Ptr, arg_ptr<T>> || std::is_same_v<Ptr, arg_ptr<const T>>;
+}  // namespace internal
 }  // namespace derecho::derecho_allocator
\ No newline at end of file
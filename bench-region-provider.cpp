@@ -0,0 +1,120 @@
+#include "message-builder.hpp"
+#include "mutils-serialization/SerializationSupport.hpp"
+#include "region-provider.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+using namespace derecho::derecho_allocator;
+
+// usage: bench-region-provider [region_size] [messages_per_thread] [threads]
+//                              [regions_in_flight_per_thread]
+//
+// Each thread keeps a ring of regions in flight and replaces one per message,
+// so the working set (region_size * in_flight * threads) can be pushed well
+// past TLB reach.  Every message fills its whole region.
+
+// int + double static args, plus the string's length prefix
+constexpr const std::size_t message_overhead = sizeof(int) + sizeof(double) + sizeof(std::size_t);
+constexpr const std::size_t min_region_size = 64;
+
+struct bench_result {
+  double seconds;
+  long minor_faults;
+  long major_faults;
+};
+
+template <typename GetRegion>
+void build_messages(std::size_t region_size, std::size_t count,
+                    std::size_t in_flight, GetRegion &&get_region) {
+  const std::string payload(region_size - message_overhead, 'x');
+  std::vector<decltype(get_region())> ring;
+  for (std::size_t n = 0; n < in_flight; ++n) {
+    ring.push_back(get_region());
+  }
+  for (std::size_t n = 0; n < count; ++n) {
+    auto &region = ring[n % in_flight];
+    region = get_region();
+    message_builder<int, double, std::string> mb(region.data(), region_size);
+    arg_ptr<int> i = mb.build_arg<0>((int)n);
+    arg_ptr<double> d = mb.build_arg<1>(3.243);
+    arg_ptr<std::string> s = mb.build_arg<2>(payload);
+    auto buf = mb.serialize(i, d, s);
+    assert(*(int *)buf == (int)n);
+    (void)buf;
+  }
+}
+
+template <typename GetRegion>
+bench_result run(std::size_t region_size, std::size_t count,
+                 std::size_t threads, std::size_t in_flight,
+                 GetRegion get_region) {
+  rusage before, after;
+  getrusage(RUSAGE_SELF, &before);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < threads; ++t) {
+    workers.emplace_back(
+        [&] { build_messages(region_size, count, in_flight, get_region); });
+  }
+  for (auto &w : workers)
+    w.join();
+  auto end = std::chrono::steady_clock::now();
+  getrusage(RUSAGE_SELF, &after);
+  return bench_result{std::chrono::duration<double>(end - start).count(),
+                      after.ru_minflt - before.ru_minflt,
+                      after.ru_majflt - before.ru_majflt};
+}
+
+void report(const char *name, const bench_result &r, std::size_t messages) {
+  std::cout << name << ": " << (messages / r.seconds) << " msg/s, "
+            << r.minor_faults << " minor faults, " << r.major_faults
+            << " major faults" << std::endl;
+}
+
+// heap buffers handed out in the same shape as serial_region
+struct heap_region {
+  std::unique_ptr<unsigned char[]> mem;
+  unsigned char *data() const { return mem.get(); }
+};
+
+int main(int argc, char **argv) {
+  const std::size_t region_size =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 16 * 1024;
+  const std::size_t count =
+      argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+  const std::size_t threads =
+      argc > 3 ? std::strtoul(argv[3], nullptr, 10)
+               : std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t in_flight =
+      argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 1024;
+  const std::size_t messages = count * threads;
+  if (region_size < min_region_size || in_flight == 0) {
+    std::cerr << "region_size must be at least " << min_region_size
+              << " and regions_in_flight_per_thread at least 1" << std::endl;
+    return 1;
+  }
+
+  auto heap = run(region_size, count, threads, in_flight, [region_size] {
+    return heap_region{std::unique_ptr<unsigned char[]>(
+        new unsigned char[region_size])};
+  });
+  report("heap buffers", heap, messages);
+
+  region_provider provider{region_size};
+  auto pooled = run(region_size, count, threads, in_flight,
+                    [&provider] { return provider.acquire(); });
+  report("region_provider (cold)", pooled, messages);
+  // second pass reuses the already-faulted mappings
+  pooled = run(region_size, count, threads, in_flight,
+               [&provider] { return provider.acquire(); });
+  report("region_provider (warm)", pooled, messages);
+}
@@ -20,7 +20,31 @@ public:
     return a.template build_arg<s, CArgs...>(std::forward<CArgs>(cargs)...);
   }
 
-  char *serialize(const arg_ptr<Args> &...) { return a.serialize(); }
+  // Records a reference to the caller's object instead of copying it into
+  // the builder; serialize() then copies it straight into the serial region.
+  // A borrowed dynamic argument must stay alive and unmodified until
+  // serialize() returns.  Static (trivially copyable) arguments are copied
+  // into the region immediately, so any value, temporaries included, is fine.
+  template <std::size_t s>
+  decltype(auto)
+  borrow_arg(const typename allocator::template get_arg<s> &borrowed) {
+    return a.template borrow_arg<s>(borrowed);
+  }
+  // a temporary dynamic argument would be destroyed before serialize() reads it
+  template <std::size_t s,
+            typename = std::enable_if_t<!allocator::template is_static<s>()>>
+  void borrow_arg(const typename allocator::template get_arg<s> &&) = delete;
+
+  template <typename... Ptrs> char *serialize(const Ptrs &...) {
+    static_assert(sizeof...(Ptrs) == sizeof...(Args),
+                  "Error: serialize needs one arg_ptr per argument");
+    if constexpr (sizeof...(Ptrs) == sizeof...(Args)) {
+      static_assert((internal::is_arg_ptr_for<Args, Ptrs> && ...),
+                    "Error: serialize arguments must be the arg_ptrs "
+                    "returned by build_arg or borrow_arg");
+    }
+    return a.serialize();
+  }
 };
 
 } // namespace derecho_allocator
@@ -0,0 +1,315 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// <linux/mman.h> has this too, but clashes with <sys/mman.h> on older libcs
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+
+namespace derecho::derecho_allocator {
+
+namespace internal {
+constexpr const std::size_t huge_page_size = 2 * 1024 * 1024;
+constexpr const std::size_t small_page_size = 4096;
+constexpr const std::size_t region_alignment = 64;
+
+constexpr std::size_t round_up(std::size_t s, std::size_t to) {
+    return ((s + to - 1) / to) * to;
+}
+
+inline std::size_t checked_region_size(std::size_t requested) {
+    if(requested == 0) throw std::invalid_argument("region_provider: region size must be nonzero");
+    return round_up(requested, region_alignment);
+}
+
+// /sys/devices/system/node/possible reads as "0" or "0-N"
+inline std::size_t numa_node_count() {
+    std::FILE* f = std::fopen("/sys/devices/system/node/possible", "r");
+    if(!f) return 1;
+    unsigned int first = 0;
+    unsigned int last = 0;
+    const int matched = std::fscanf(f, "%u-%u", &first, &last);
+    std::fclose(f);
+    if(matched == 2) return last + 1;
+    if(matched == 1) return first + 1;
+    return 1;
+}
+
+inline std::size_t current_numa_node() {
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if(syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return 0;
+    return node;
+}
+
+struct huge_mapping {
+    unsigned char* base{nullptr};
+    std::size_t size{0};
+    bool explicit_huge_pages{false};
+
+    huge_mapping() = default;
+    huge_mapping(const huge_mapping&) = delete;
+    huge_mapping(huge_mapping&& o)
+            : base(o.base), size(o.size), explicit_huge_pages(o.explicit_huge_pages) {
+        o.base = nullptr;
+    }
+    ~huge_mapping() {
+        if(base) munmap(base, size);
+    }
+
+    // size must be a multiple of huge_page_size.  Tries MAP_HUGETLB first,
+    // asking for 2MB pages explicitly since the default may be 1GB; if none
+    // are reserved, falls back to a 2MB-aligned normal mapping with
+    // MADV_HUGEPAGE (which the kernel is free to ignore).
+    // Either way the memory is bound to node and pre-faulted before return.
+    huge_mapping(std::size_t size, std::size_t node) : size(size) {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+        if(p != MAP_FAILED) {
+            explicit_huge_pages = true;
+            base = (unsigned char*)p;
+        } else {
+            const std::size_t padded = size + huge_page_size;
+            p = mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(p == MAP_FAILED) throw std::bad_alloc();
+            unsigned char* raw = (unsigned char*)p;
+            base = (unsigned char*)round_up((std::size_t)raw, huge_page_size);
+            if(base != raw) munmap(raw, base - raw);
+            if(base + size != raw + padded) munmap(base + size, (raw + padded) - (base + size));
+            madvise(base, size, MADV_HUGEPAGE);
+        }
+        // MPOL_PREFERRED rather than MPOL_BIND so a full node degrades to
+        // remote memory instead of failing.  Failure (e.g. no NUMA support)
+        // is harmless: we just get the default first-touch placement.
+        constexpr const std::size_t bits = 8 * sizeof(unsigned long);
+        std::vector<unsigned long> mask(node / bits + 1, 0);
+        mask[node / bits] = 1ul << (node % bits);
+        syscall(SYS_mbind, base, size, MPOL_PREFERRED, mask.data(), mask.size() * bits + 1, 0);
+        const std::size_t page_size = explicit_huge_pages ? huge_page_size : small_page_size;
+        for(std::size_t off = 0; off < size; off += page_size) {
+            ((volatile unsigned char*)base)[off] = 0;
+        }
+    }
+};
+}  // namespace internal
+
+class region_provider;
+
+/**
+ * A fixed-size serial region on loan from a region_provider.  Returns
+ * itself to the provider on destruction; pass data() and size() straight
+ * to the message_builder constructor.
+ */
+class serial_region {
+    friend class region_provider;
+    region_provider* owner{nullptr};
+    std::size_t node{0};
+    unsigned char* region{nullptr};
+    std::size_t region_size{0};
+
+    serial_region(region_provider* owner, std::size_t node, unsigned char* region, std::size_t region_size)
+            : owner(owner), node(node), region(region), region_size(region_size) {}
+
+public:
+    serial_region() = default;
+    serial_region(const serial_region&) = delete;
+    serial_region(serial_region&& o)
+            : owner(o.owner), node(o.node), region(o.region), region_size(o.region_size) {
+        o.owner = nullptr;
+    }
+    serial_region& operator=(serial_region&& o);
+    ~serial_region();
+
+    unsigned char* data() const { return region; }
+    std::size_t size() const { return region_size; }
+};
+
+/**
+ * Hands out fixed-size serial regions carved from pre-faulted 2MB huge-page
+ * mappings, keeping one pool per NUMA node.  Each thread draws from the pool
+ * of the node it first called acquire() on, through a small per-thread cache
+ * that is refilled and drained in batches so the hot path takes no lock.
+ * The provider must outlive every region it hands out.
+ */
+class region_provider {
+    struct node_pool {
+        std::mutex m;
+        std::vector<internal::huge_mapping> chunks;
+        std::vector<unsigned char*> free_regions;
+    };
+
+    // Owned jointly with the thread caches, so a thread exiting after the
+    // provider is gone can tell not to drain into it.
+    struct shared_pools {
+        const std::size_t region_size;
+        const std::size_t chunk_size;
+        const std::size_t node_count;
+        std::unique_ptr<node_pool[]> pools;
+
+        shared_pools(std::size_t region_size, std::size_t chunk_size)
+                : region_size(internal::checked_region_size(region_size)),
+                  chunk_size(internal::round_up(std::max(chunk_size, this->region_size), internal::huge_page_size)),
+                  node_count(internal::numa_node_count()),
+                  pools(new node_pool[node_count]) {}
+
+        // The chunk is mapped and faulted in before taking the pool's mutex,
+        // so other threads on this node keep acquiring and releasing
+        // meanwhile.  Two threads may race to grow the same pool; both
+        // chunks are kept.
+        void grow(std::size_t node) {
+            internal::huge_mapping chunk{chunk_size, node};
+            unsigned char* base = chunk.base;
+            node_pool& pool = pools[node];
+            std::lock_guard<std::mutex> lock{pool.m};
+            pool.chunks.push_back(std::move(chunk));
+            for(std::size_t off = chunk_size; off >= region_size; off -= region_size) {
+                pool.free_regions.push_back(base + off - region_size);
+            }
+        }
+
+        void refill(std::size_t node, std::vector<unsigned char*>& cache) {
+            node_pool& pool = pools[node];
+            while(true) {
+                {
+                    std::lock_guard<std::mutex> lock{pool.m};
+                    if(!pool.free_regions.empty()) {
+                        const std::size_t n = std::min(cache_batch, pool.free_regions.size());
+                        cache.insert(cache.end(), pool.free_regions.end() - n, pool.free_regions.end());
+                        pool.free_regions.resize(pool.free_regions.size() - n);
+                        return;
+                    }
+                }
+                grow(node);
+            }
+        }
+
+        // moves the oldest n cached regions back to the node pool
+        void drain(std::size_t node, std::vector<unsigned char*>& cache, std::size_t n) {
+            node_pool& pool = pools[node];
+            std::lock_guard<std::mutex> lock{pool.m};
+            pool.free_regions.insert(pool.free_regions.end(), cache.begin(), cache.begin() + n);
+            cache.erase(cache.begin(), cache.begin() + n);
+        }
+    };
+
+    static constexpr const std::size_t cache_batch = 32;
+
+    struct thread_cache {
+        std::uint64_t provider_id;
+        std::size_t node;
+        std::weak_ptr<shared_pools> owner;
+        std::vector<unsigned char*> regions;
+    };
+
+    struct thread_caches {
+        std::vector<thread_cache> caches;
+        ~thread_caches() {
+            for(thread_cache& c : caches) {
+                if(auto owner = c.owner.lock()) owner->drain(c.node, c.regions, c.regions.size());
+            }
+        }
+    };
+
+    static std::uint64_t next_id() {
+        static std::atomic<std::uint64_t> id{0};
+        return id++;
+    }
+
+    const std::uint64_t id;
+    const std::shared_ptr<shared_pools> shared;
+
+    static std::size_t local_node() {
+        // cached: a getcpu syscall per message would cost more than the
+        // occasional remote access after the scheduler migrates a thread
+        static thread_local const std::size_t node = internal::current_numa_node();
+        return node;
+    }
+
+    thread_cache& local_cache() {
+        static thread_local thread_caches tls;
+        for(thread_cache& c : tls.caches) {
+            if(c.provider_id == id) return c;
+        }
+        // first use of this provider on this thread; drop caches left behind
+        // by providers that have since been destroyed
+        tls.caches.erase(std::remove_if(tls.caches.begin(), tls.caches.end(),
+                                        [](const thread_cache& c) { return c.owner.expired(); }),
+                         tls.caches.end());
+        std::size_t node = local_node();
+        if(node >= shared->node_count) node = 0;
+        tls.caches.push_back(thread_cache{id, node, shared, {}});
+        tls.caches.back().regions.reserve(2 * cache_batch);
+        return tls.caches.back();
+    }
+
+    friend class serial_region;
+    void release(std::size_t node, unsigned char* region) {
+        thread_cache& cache = local_cache();
+        if(node != cache.node) {
+            // keep remote regions out of this thread's cache so they are only
+            // ever reissued on their own node
+            node_pool& pool = shared->pools[node];
+            std::lock_guard<std::mutex> lock{pool.m};
+            pool.free_regions.push_back(region);
+            return;
+        }
+        cache.regions.push_back(region);
+        if(cache.regions.size() >= 2 * cache_batch) shared->drain(node, cache.regions, cache_batch);
+    }
+
+public:
+    region_provider(std::size_t region_size, std::size_t chunk_size = internal::huge_page_size)
+            : id(next_id()), shared(std::make_shared<shared_pools>(region_size, chunk_size)) {}
+
+    // serial_regions point back at their provider
+    region_provider(const region_provider&) = delete;
+    region_provider(region_provider&&) = delete;
+    region_provider& operator=(const region_provider&) = delete;
+    region_provider& operator=(region_provider&&) = delete;
+
+    serial_region acquire() {
+        thread_cache& cache = local_cache();
+        if(cache.regions.empty()) shared->refill(cache.node, cache.regions);
+        unsigned char* region = cache.regions.back();
+        cache.regions.pop_back();
+        return serial_region{this, cache.node, region, shared->region_size};
+    }
+
+    std::size_t get_region_size() const { return shared->region_size; }
+};
+
+inline serial_region& serial_region::operator=(serial_region&& o) {
+    if(this != &o) {
+        if(owner) owner->release(node, region);
+        owner = o.owner;
+        node = o.node;
+        region = o.region;
+        region_size = o.region_size;
+        o.owner = nullptr;
+    }
+    return *this;
+}
+
+inline serial_region::~serial_region() {
+    if(owner) owner->release(node, region);
+}
+
+}  // namespace derecho::derecho_allocator
@@ -1,8 +1,13 @@
 #include "message-builder.hpp"
 #include "mutils-serialization/SerializationSupport.hpp"
+#include <algorithm>
 #include <array>
 #include <list>
 #include <string>
+#include <vector>
+#ifdef __linux__
+#include "region-provider.hpp"
+#endif
 
 using namespace derecho::derecho_allocator;
 
@@ -161,10 +166,90 @@ void test6() {
       });
 }
 
+void test7() {
+  std::array<unsigned char, 1024> mem;
+  message_builder<int, char, std::string, std::list<char>> mb(mem.data(),
+                                                              sizeof(mem));
+  const int cached_i = 15;
+  const std::string cached_s = "str";
+  std::list<char> reference_l;
+  for (char i = 0; i < 'Z'; ++i) {
+    reference_l.push_back(i);
+  }
+  arg_ptr<const int> i = mb.borrow_arg<0>(cached_i);
+  arg_ptr<const char> c = mb.borrow_arg<1>('e');
+  arg_ptr<const std::string> s = mb.borrow_arg<2>(cached_s);
+  arg_ptr<const std::list<char>> l = mb.borrow_arg<3>(reference_l);
+  assert(s.get() == &cached_s);
+  assert(l.get() == &reference_l);
+  auto buf = mb.serialize(i, c, s, l);
+  mutils::deserialize_and_run(nullptr, buf,
+                              [reference_l](const int &i, const char &c,
+                                            const std::string &s,
+                                            const std::list<char> &l) {
+                                assert(i == 15);
+                                assert(c == 'e');
+                                assert(s == "str");
+                                assert(l == reference_l);
+                              });
+}
+
+#ifdef __linux__
+void test8() {
+  const std::size_t requested = 1000;
+  region_provider provider{requested};
+  std::vector<serial_region> regions;
+  for (int n = 0; n < 5000; ++n) {
+    regions.push_back(provider.acquire());
+    assert(regions.back().size() >= requested);
+  }
+  std::vector<std::pair<unsigned char *, unsigned char *>> extents;
+  for (const auto &r : regions) {
+    extents.emplace_back(r.data(), r.data() + r.size());
+  }
+  std::sort(extents.begin(), extents.end());
+  for (std::size_t n = 1; n < extents.size(); ++n) {
+    assert(extents[n - 1].second <= extents[n].first);
+  }
+
+  [[maybe_unused]] unsigned char *released = regions.back().data();
+  regions.pop_back();
+  serial_region reused = provider.acquire();
+  assert(reused.data() == released);
+
+  message_builder<int, char, std::string, std::list<char>> mb(reused.data(),
+                                                              reused.size());
+  arg_ptr<int> i = mb.build_arg<0>(15);
+  arg_ptr<char> c = mb.build_arg<1>('e');
+  arg_ptr<std::string> s = mb.build_arg<2>("str");
+  std::list<char> reference_l;
+  arg_ptr<std::list<char>> l = mb.build_arg<3>();
+  for (char i = 0; i < 'Z'; ++i) {
+    l->push_back(i);
+    reference_l.push_back(i);
+  }
+  auto buf = mb.serialize(i, c, s, l);
+  assert((unsigned char *)buf == reused.data());
+  mutils::deserialize_and_run(nullptr, buf,
+                              [reference_l](const int &i, const char &c,
+                                            const std::string &s,
+                                            const std::list<char> &l) {
+                                assert(i == 15);
+                                assert(c == 'e');
+                                assert(s == "str");
+                                assert(l == reference_l);
+                              });
+}
+#endif
+
 int main() {
   test1();
   test2();
   test3();
   test4();
   test5();
+  test7();
+#ifdef __linux__
+  test8();
+#endif
 }